@@ -0,0 +1,154 @@
+// Load generator for the live mode: replays the same multi-venue day through
+// EventRouter with 1, 2, 4, ... shards and reports throughput and tail latency.
+//
+// Usage: ClubBench [--venues <count>] [--clients <count>] [--max-shards <count>]
+//
+// Latency is measured with probes: every probe_every lines a "RESULT p<i>" line for an
+// empty venue is routed, and the time until its result reaches the output is recorded.
+// It covers queueing behind the preceding events of the shard, not just the handling.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Club/EventRouter.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::size_t probe_every = 1000;
+
+    std::string format_time(const int minute) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "%02d:%02d", minute / 60 % 24, minute % 60);
+        return buf;
+    }
+
+    // The same day in every venue, venues interleaved line by line as a live feed would be
+    std::vector<std::string> generate(const int venues, const int clients) {
+        std::vector<std::string> lines;
+        lines.reserve(static_cast<std::size_t>(venues) * (4 + clients * 3));
+        const auto add = [&](const std::string &body) {
+            for (int v = 0; v < venues; v++) {
+                lines.push_back("v" + std::to_string(v) + " " + body);
+            }
+        };
+        add("5");
+        add("08:00 23:00");
+        add("7");
+        for (int c = 0; c < clients; c++) {
+            const std::string time = format_time(8 * 60 + c * 4);
+            const std::string name = "c" + std::to_string(c);
+            add(time + " 1 " + name);
+            add(time + " 2 " + name + " " + std::to_string(c % 5 + 1));
+            add(time + " 4 " + name);
+        }
+        for (int v = 0; v < venues; v++) {
+            lines.push_back("CLOSE v" + std::to_string(v));
+        }
+        return lines;
+    }
+
+    // Discards the output, only noting when the result of each probe arrives
+    class ProbeSink : public std::streambuf {
+        std::mutex mutex;
+
+    public:
+        std::vector<Clock::time_point> arrived;
+
+        explicit ProbeSink(const std::size_t probes) : arrived(probes) {
+        }
+
+    protected:
+        std::streamsize xsputn(const char *s, const std::streamsize n) override {
+            // the router writes every result with a single call, tagged with its venue
+            if (n > 1 && s[0] == 'p') {
+                const Clock::time_point now = Clock::now();
+                const std::size_t probe = std::stoul(std::string(s + 1, n - 1));
+                const std::lock_guard lock(mutex);
+                arrived[probe] = now;
+            }
+            return n;
+        }
+
+        int_type overflow(const int_type c) override {
+            return traits_type::not_eof(c);
+        }
+    };
+
+    struct Result {
+        double events_per_second;
+        double p50_us;
+        double p99_us;
+    };
+
+    Result run(const std::vector<std::string> &lines, const unsigned shards) {
+        const std::size_t probes = lines.size() / probe_every + 1;
+        ProbeSink sink(probes);
+        std::ostream out(&sink);
+        std::vector<Clock::time_point> sent(probes);
+
+        const Clock::time_point start = Clock::now();
+        {
+            club::EventRouter router(shards, out);
+            for (std::size_t i = 0; i < lines.size(); i++) {
+                if (i % probe_every == 0) {
+                    const std::size_t probe = i / probe_every;
+                    sent[probe] = Clock::now();
+                    router.route("RESULT p" + std::to_string(probe));
+                }
+                router.route(lines[i]);
+            }
+            router.stop();
+        }
+        const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+        std::vector<double> latencies;
+        latencies.reserve(probes);
+        for (std::size_t i = 0; i < probes; i++) {
+            latencies.push_back(std::chrono::duration<double, std::micro>(sink.arrived[i] - sent[i]).count());
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&](const double p) {
+            return latencies[static_cast<std::size_t>(p * static_cast<double>(latencies.size() - 1))];
+        };
+        return {static_cast<double>(lines.size()) / elapsed.count(), percentile(0.5), percentile(0.99)};
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int venues = 2000;
+    int clients = 200;
+    unsigned max_shards = std::max(4u, std::thread::hardware_concurrency());
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        if (arg == "--venues") {
+            venues = std::stoi(argv[i + 1]);
+        } else if (arg == "--clients") {
+            clients = std::stoi(argv[i + 1]);
+        } else if (arg == "--max-shards") {
+            max_shards = std::stoul(argv[i + 1]);
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                    << " [--venues <count>] [--clients <count>] [--max-shards <count>]" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::vector<std::string> lines = generate(venues, clients);
+    std::cout << lines.size() << " lines, " << venues << " venues, "
+            << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    std::cout << "shards  events/s  p50 us  p99 us" << std::endl;
+    for (unsigned shards = 1; shards <= max_shards; shards *= 2) {
+        const auto [events_per_second, p50, p99] = run(lines, shards);
+        char row[80];
+        std::snprintf(row, sizeof(row), "%6u %9.0f %7.0f %7.0f", shards, events_per_second, p50, p99);
+        std::cout << row << std::endl;
+    }
+    return 0;
+}
@@ -4,22 +4,31 @@
 #include <memory>
 #include <deque>
 #include <iostream>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include "Events.h"
 
 namespace club {
+    enum class OutputFormat {
+        Text,
+        // see Columnar.h, the column set is documented at Club::print_columns
+        Columnar,
+    };
+
     class Club {
-        std::ifstream conf;
         std::ostream& out;
         bool is_corrupted = false;
+        bool kick_out_is_handled = false;
         int total_tables = 0;
         int start_time = 0;
         int finish_time = 0;
         int hour_cost = 0;
         int line_num = 0;
         int last_event_time = 0;
+        std::string bad_line;
+        int bad_line_num = 0;
         std::vector<std::unique_ptr<Event> > events;
         std::vector<std::unique_ptr<Event> > resulting_events;
 
@@ -31,12 +40,51 @@ namespace club {
         std::deque<std::string> queue;
         int empty_tables = 0;
 
+        // dense client ids, assigned on first use
+        std::unordered_map<std::string, int> client_ids;
+        std::vector<std::string> client_names;
+
+        // per-client billing, indexed by client id, and the (client, table) of every billed session
+        bool keeps_ledger = false;
+        std::vector<int> ledger_sessions;
+        std::vector<int> ledger_hours;
+        std::vector<int> ledger_amount;
+        std::vector<int> session_client;
+        std::vector<int> session_table;
+
     public:
+        // Bumped whenever the simulation rules or the output format change,
+        // so that results cached by older builds are never served.
+        static constexpr std::string_view engine_version = "1";
+
+        // gzip and zstd compressed input is detected and decompressed on the fly
         explicit Club(const std::string &, std::ostream& = std::cout);
 
-        void run();
+        explicit Club(std::istream &, std::ostream& = std::cout);
+
+        // Live club: lines are fed one by one and events are handled as they arrive
+        static Club live(std::ostream &);
+
+        // Also bill every client separately, the ledger is printed after the per-table summary
+        void enable_ledger();
+
+        void run(OutputFormat = OutputFormat::Text);
+
+        // Returns false once the club is corrupted, the rest of the lines are ignored then
+        bool feed(const std::string &);
+
+        // Kicks out the remaining clients, no events are expected after that
+        void close();
+
+        // Prints the result so far, or the offending line for a corrupted club
+        void report(OutputFormat = OutputFormat::Text);
 
     private:
+        struct LiveTag {
+        };
+
+        Club(LiveTag, std::ostream &);
+
         static std::vector<std::string> split(const std::string &, char);
 
         static bool parse_time(const std::string &, int &);
@@ -49,10 +97,22 @@ namespace club {
 
         bool parse_event(const std::vector<std::string> &);
 
-        int charge_money(int time) const;
+        bool parse_line(const std::string &);
+
+        void prepare();
+
+        static int billed_hours(int time);
+
+        void charge_session(const std::string &client, int table, int time);
+
+        int client_id(const std::string &);
+
+        [[nodiscard]] std::vector<std::pair<int, int> > ledger_tables() const;
 
         void handle_events();
 
+        void handle_event(std::unique_ptr<Event> event);
+
         void handle_client_come(const EventClientCome &event);
 
         void handle_client_sit(EventClientSit &event);
@@ -65,7 +125,11 @@ namespace club {
 
         void print_result() const;
 
-        void parse();
+        void print_ledger() const;
+
+        void print_columns();
+
+        void parse(std::istream &);
     };
 } // club
 
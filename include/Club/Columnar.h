@@ -0,0 +1,116 @@
+#ifndef CLUB_COLUMNAR_H
+#define CLUB_COLUMNAR_H
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace club {
+    // Binary container of named typed columns.
+    //
+    // Layout (native little-endian): a FileHeader, then FileHeader::column_count ColumnEntry
+    // records, then the raw column arrays. Every array starts at an offset that is a multiple
+    // of 8 from the beginning of the file, so a mapped file can be used in place.
+    namespace columnar {
+        constexpr char magic[8] = {'C', 'L', 'U', 'B', 'C', 'O', 'L', '1'};
+
+        enum class Type : std::uint32_t {
+            Int32 = 1,
+            Int64 = 2,
+            UInt8 = 3,
+            UInt32 = 4,
+            Char = 5,
+        };
+
+        struct FileHeader {
+            char magic[8];
+            std::uint32_t column_count;
+            std::uint32_t reserved;
+        };
+
+        struct ColumnEntry {
+            char name[32];
+            Type type;
+            std::uint32_t reserved;
+            std::uint64_t count;
+            std::uint64_t offset;
+        };
+
+        template<typename T>
+        constexpr Type type_of();
+
+        template<>
+        constexpr Type type_of<std::int32_t>() { return Type::Int32; }
+
+        template<>
+        constexpr Type type_of<std::int64_t>() { return Type::Int64; }
+
+        template<>
+        constexpr Type type_of<std::uint8_t>() { return Type::UInt8; }
+
+        template<>
+        constexpr Type type_of<std::uint32_t>() { return Type::UInt32; }
+
+        template<>
+        constexpr Type type_of<char>() { return Type::Char; }
+    }
+
+    class ColumnarWriter {
+        struct Column {
+            std::string name;
+            columnar::Type type;
+            std::uint64_t count;
+            std::string bytes;
+        };
+
+        std::vector<Column> columns;
+
+    public:
+        template<typename T>
+        void add(std::string name, const std::vector<T> &values) {
+            add(std::move(name), columnar::type_of<T>(), values.size(),
+                {reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T)});
+        }
+
+        // Adds a string dictionary as two columns: "<name>.offsets" (count + 1 entries) and "<name>.data"
+        void add_strings(const std::string &name, const std::vector<std::string> &values);
+
+        void write(std::ostream &out) const;
+
+    private:
+        void add(std::string name, columnar::Type type, std::uint64_t count, std::string_view bytes);
+    };
+
+    class ColumnarReader {
+        std::string_view data;
+        std::span<const columnar::ColumnEntry> entries;
+
+    public:
+        // data must stay alive and be 8-byte aligned, throws std::runtime_error on malformed input
+        explicit ColumnarReader(std::string_view data);
+
+        [[nodiscard]] bool has(std::string_view name) const;
+
+        template<typename T>
+        [[nodiscard]] std::span<const T> column(const std::string_view name) const {
+            const columnar::ColumnEntry &entry = find(name);
+            if (entry.type != columnar::type_of<T>()) {
+                throw std::runtime_error("column " + std::string(name) + " has another type");
+            }
+            return {reinterpret_cast<const T *>(data.data() + entry.offset), entry.count};
+        }
+
+        [[nodiscard]] std::vector<std::string_view> strings(const std::string &name) const;
+
+    private:
+        [[nodiscard]] const columnar::ColumnEntry *lookup(std::string_view name) const;
+
+        [[nodiscard]] const columnar::ColumnEntry &find(std::string_view name) const;
+    };
+} // club
+
+#endif //CLUB_COLUMNAR_H
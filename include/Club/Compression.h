@@ -0,0 +1,105 @@
+#ifndef CLUB_COMPRESSION_H
+#define CLUB_COMPRESSION_H
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+
+namespace club {
+    enum class Compression {
+        None,
+        Gzip,
+        Zstd,
+    };
+
+    // Availability depends on the libraries found at build time
+    [[nodiscard]] bool is_supported(Compression);
+
+    // Parses "none", "gzip" or "zstd", returns false for anything else
+    bool parse_compression(std::string_view, Compression &);
+
+    // Looks at the magic bytes at the start of the data
+    [[nodiscard]] Compression detect_compression(std::string_view prefix);
+
+    class Codec;
+
+    // Decompresses the source stream in large blocks as it is read.
+    // Broken or truncated archives throw std::runtime_error out of the read calls.
+    class DecompressingStream : public std::istream {
+        class Buffer : public std::streambuf {
+            std::streambuf &source;
+            Compression compression;
+            std::unique_ptr<Codec> codec;
+            std::unique_ptr<char[]> in;
+            std::unique_ptr<char[]> out;
+            std::size_t in_begin = 0;
+            std::size_t in_end = 0;
+            bool is_source_exhausted = false;
+
+        public:
+            Buffer(std::streambuf &source, Compression compression);
+
+            // Reads just the magic bytes to detect the format, they are decoded (or
+            // passed through) later like the rest of the input
+            explicit Buffer(std::streambuf &source);
+
+            ~Buffer() override;
+
+            [[nodiscard]] Compression format() const { return compression; }
+
+        protected:
+            int_type underflow() override;
+
+        private:
+            int_type pass_through();
+        };
+
+        Buffer buffer;
+
+    public:
+        DecompressingStream(std::istream &source, Compression compression);
+
+        // Detects the format from the first bytes, plain input is passed through as is.
+        // The source is never seeked, so pipes and FIFOs work as well as files
+        explicit DecompressingStream(std::istream &source);
+
+        [[nodiscard]] Compression compression() const { return buffer.format(); }
+    };
+
+    // Compresses everything written to it into the sink stream.
+    // flush() only keeps the data buffered, finish() (or the destructor) ends the compressed stream.
+    class CompressingStream : public std::ostream {
+        class Buffer : public std::streambuf {
+            std::ostream &sink;
+            std::unique_ptr<Codec> codec;
+            std::unique_ptr<char[]> in;
+            std::unique_ptr<char[]> out;
+            bool is_finished = false;
+
+        public:
+            Buffer(std::ostream &sink, Compression compression);
+
+            ~Buffer() override;
+
+            void finish();
+
+        protected:
+            int_type overflow(int_type) override;
+
+            int sync() override;
+
+        private:
+            void compress(bool is_last);
+        };
+
+        Buffer buffer;
+
+    public:
+        CompressingStream(std::ostream &sink, Compression compression);
+
+        void finish();
+    };
+} // club
+
+#endif //CLUB_COMPRESSION_H
@@ -0,0 +1,62 @@
+#ifndef CLUB_EVENT_ROUTER_H
+#define CLUB_EVENT_ROUTER_H
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "SpscQueue.h"
+
+namespace club {
+    // Hosts the live state of many clubs ("venues") in one process.
+    //
+    // Every input line is either "<venue> <club line>", "RESULT <venue>" or "CLOSE <venue>".
+    // Venues are hash-sharded onto worker threads; each worker exclusively owns the clubs
+    // of its shard, so events are handled without any locking. Only the single thread
+    // calling route() may feed the router. If handling a line of a venue throws, only that
+    // venue fails: its result becomes "Error: <message>" and its later lines are ignored.
+    class EventRouter {
+        struct Shard;
+
+        std::ostream &out;
+        std::mutex out_mutex;
+        std::vector<std::unique_ptr<Shard> > shards;
+        bool is_stopped = false;
+
+    public:
+        // shards == 0 means one shard per hardware thread
+        explicit EventRouter(unsigned shards = 0, std::ostream &out = std::cout);
+
+        ~EventRouter();
+
+        EventRouter(const EventRouter &) = delete;
+
+        EventRouter &operator=(const EventRouter &) = delete;
+
+        // Returns false and drops the line if it names no venue, e.g. a bare "RESULT"
+        bool route(std::string line);
+
+        // Routes every line of the stream, then waits for all of them to be handled.
+        // Dropped lines are reported to err
+        void serve(std::istream &in, std::ostream &err = std::cerr);
+
+        // Waits for all routed lines to be handled and stops the workers
+        void stop();
+
+        [[nodiscard]] unsigned shard_count() const { return static_cast<unsigned>(shards.size()); }
+
+    private:
+        static std::string_view venue_of(std::string_view line);
+
+        void work(Shard &shard);
+
+        void handle(Shard &shard, std::string &line);
+
+        void emit(std::string_view venue, const std::string &result);
+    };
+} // club
+
+#endif //CLUB_EVENT_ROUTER_H
@@ -0,0 +1,108 @@
+#ifndef CLUB_RESULT_CACHE_H
+#define CLUB_RESULT_CACHE_H
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace club {
+    // On-disk cache of finished results keyed by the input bytes.
+    // Several processes may share one directory: entries are published with an
+    // atomic rename, so a reader sees either a complete entry or none at all.
+    // Statistics and the running size estimate are kept in the mapped "stats" file of
+    // the directory and updated atomically, so they add up over all workers
+    // (on platforms without mmap they only cover the current process).
+    class ResultCache {
+    public:
+        struct Stats {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t evictions = 0;
+        };
+
+        // A result being written; it becomes visible to lookup() only once committed,
+        // and is thrown away if the Entry is destroyed before that
+        class Entry {
+            friend class ResultCache;
+            ResultCache *cache;
+            std::string key;
+            std::filesystem::path tmp_path;
+            std::unique_ptr<std::ofstream> file;
+
+            Entry(ResultCache &cache, std::string key);
+
+        public:
+            Entry(Entry &&) noexcept = default;
+
+            ~Entry();
+
+            std::ostream &stream();
+
+            void commit();
+        };
+
+        // max_bytes == 0 disables eviction
+        ResultCache(std::filesystem::path dir, std::uintmax_t max_bytes = 0);
+
+        ~ResultCache();
+
+        ResultCache(const ResultCache &) = delete;
+
+        ResultCache &operator=(const ResultCache &) = delete;
+
+        // variant must describe everything besides the input that affects the
+        // result (engine version, output options)
+        [[nodiscard]] static std::string make_key(std::string_view input, std::string_view variant);
+
+        // Same key as above, the input is hashed block by block as it is read
+        [[nodiscard]] static std::string make_key(std::istream &input, std::string_view variant);
+
+        bool lookup(const std::string &key, std::ostream &out);
+
+        [[nodiscard]] Entry begin_store(const std::string &key);
+
+        void store(const std::string &key, std::string_view result);
+
+        // Totals for everybody sharing the directory
+        [[nodiscard]] Stats stats() const;
+
+    private:
+        struct Counters {
+            std::uint64_t hits;
+            std::uint64_t misses;
+            std::uint64_t evictions;
+            // estimate of the total size of entries, only triggers a directory scan
+            std::uint64_t bytes;
+        };
+
+        std::filesystem::path dir;
+        std::uintmax_t max_bytes;
+        Counters local_counters{};
+        Counters *counters = &local_counters;
+
+        void add(std::uint64_t Counters::*counter, std::uint64_t value) const;
+
+        [[nodiscard]] std::uint64_t load(std::uint64_t Counters::*counter) const;
+
+        // Maps the shared counters, returns false if they were just created
+        bool map_counters();
+
+        std::uint64_t measure_size();
+
+        static constexpr std::uint64_t hash_seed = 0xcbf29ce484222325ULL;
+
+        static std::uint64_t hash(std::string_view, std::uint64_t seed = hash_seed);
+
+        static std::string format_key(std::uint64_t input_hash, std::uint64_t input_size, std::string_view variant);
+
+        [[nodiscard]] std::filesystem::path entry_path(const std::string &key) const;
+
+        void evict();
+    };
+} // club
+
+#endif //CLUB_RESULT_CACHE_H
@@ -0,0 +1,58 @@
+#ifndef CLUB_SPSC_QUEUE_H
+#define CLUB_SPSC_QUEUE_H
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace club {
+    // Bounded lock-free queue for exactly one producer and one consumer thread.
+    template<typename T>
+    class SpscQueue {
+        std::vector<T> slots;
+        std::size_t mask;
+        // head and tail live on separate cache lines so the two threads don't fight over them
+        alignas(64) std::atomic<std::size_t> head = 0;
+        alignas(64) std::atomic<std::size_t> tail = 0;
+
+    public:
+        // capacity is rounded up to a power of two
+        explicit SpscQueue(std::size_t capacity) {
+            std::size_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            slots.resize(size);
+            mask = size - 1;
+        }
+
+        bool try_push(T &&value) {
+            const std::size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == slots.size()) {
+                return false;
+            }
+            slots[t & mask] = std::move(value);
+            tail.store(t + 1, std::memory_order_release);
+            tail.notify_one();
+            return true;
+        }
+
+        bool try_pop(T &value) {
+            const std::size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = std::move(slots[h & mask]);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Blocks the consumer until something is pushed after it last saw the queue empty
+        void wait() const {
+            const std::size_t h = head.load(std::memory_order_relaxed);
+            tail.wait(h, std::memory_order_acquire);
+        }
+    };
+} // club
+
+#endif //CLUB_SPSC_QUEUE_H
@@ -1,52 +1,125 @@
 #include "Club/Club.h"
+#include "Club/Columnar.h"
+#include "Club/Compression.h"
 #include "Club/Utils.h"
 #include <algorithm>
 #include <charconv>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <vector>
 
 namespace club {
-    Club::Club(const std::string &filename, std::ostream& out) : conf(filename), out(out) {
-        parse();
+    Club::Club(const std::string &filename, std::ostream& out) : out(out) {
+        // opened once and read front to back, so a pipe or FIFO can be given as well
+        std::ifstream file(filename, std::ios::binary);
+        DecompressingStream conf(file);
+        parse(conf);
     }
 
-    void Club::parse() {
+    Club::Club(std::istream &conf, std::ostream& out) : out(out) {
+        DecompressingStream decompressed(conf);
+        parse(decompressed);
+    }
+
+    Club::Club(LiveTag, std::ostream& out) : out(out) {
+    }
+
+    Club Club::live(std::ostream& out) {
+        return {LiveTag{}, out};
+    }
+
+    void Club::parse(std::istream &conf) {
         std::string line;
         bool is_ok = true;
         while (is_ok && std::getline(conf, line)) {
-            ++line_num;
-            std::vector<std::string> tokens = split(line, ' ');
-            if (line_num == 1) {
-                is_ok = tokens.size() == 1 && parse_positive_int(tokens[0], total_tables);
-            } else if (line_num == 2) {
-                is_ok = tokens.size() == 2 && parse_times(tokens[0], start_time, tokens[1], finish_time);
-            } else if (line_num == 3) {
-                is_ok = tokens.size() == 1 && parse_positive_int(tokens[0], hour_cost);
-            } else {
-                is_ok = parse_event(tokens);
+#ifdef _WIN32
+            // the input is read in binary mode to detect compression
+            if (line.ends_with('\r')) {
+                line.pop_back();
             }
+#endif
+            is_ok = parse_line(line);
         }
         if (!is_ok || line_num < 3) {
-            out << line << std::endl;
+            bad_line = line;
+            bad_line_num = is_ok ? line_num + 1 : line_num;
             is_corrupted = true;
         }
-        if (conf.is_open()) {
-            conf.close();
-        }
     }
 
-    void Club::run() {
-        if (is_corrupted) {
-            return;
+    bool Club::parse_line(const std::string &line) {
+        ++line_num;
+        std::vector<std::string> tokens = split(line, ' ');
+        if (line_num == 1) {
+            return tokens.size() == 1 && parse_positive_int(tokens[0], total_tables);
+        }
+        if (line_num == 2) {
+            return tokens.size() == 2 && parse_times(tokens[0], start_time, tokens[1], finish_time);
         }
+        if (line_num == 3) {
+            return tokens.size() == 1 && parse_positive_int(tokens[0], hour_cost);
+        }
+        return parse_event(tokens);
+    }
+
+    void Club::prepare() {
         empty_tables = total_tables;
         sitting_client.resize(total_tables);
         sitting_start_time.resize(total_tables, -1);
         cumulative_time.resize(total_tables);
         revenue.resize(total_tables);
+    }
+
+    void Club::run(const OutputFormat format) {
+        if (!is_corrupted) {
+            prepare();
+            handle_events();
+        }
+        report(format);
+    }
+
+    bool Club::feed(const std::string &line) {
+        if (is_corrupted) {
+            return false;
+        }
+        if (!parse_line(line)) {
+            bad_line = line;
+            bad_line_num = line_num;
+            is_corrupted = true;
+            return false;
+        }
+        if (line_num == 3) {
+            prepare();
+        } else if (line_num > 3) {
+            std::unique_ptr<Event> event = std::move(events.back());
+            events.pop_back();
+            handle_event(std::move(event));
+        }
+        return true;
+    }
+
+    void Club::enable_ledger() {
+        keeps_ledger = true;
+    }
+
+    void Club::close() {
+        if (is_corrupted || line_num < 3 || kick_out_is_handled) {
+            return;
+        }
+        handle_kick_out();
+        kick_out_is_handled = true;
+    }
 
-        handle_events();
+    void Club::report(const OutputFormat format) {
+        if (format == OutputFormat::Columnar) {
+            print_columns();
+            return;
+        }
+        if (is_corrupted || line_num < 3) {
+            out << bad_line << std::endl;
+            return;
+        }
         print_result();
     }
 
@@ -132,37 +205,84 @@ namespace club {
         return true;
     }
 
-    int Club::charge_money(const int time) const {
-        return (time + 59) / 60 * hour_cost;
+    int Club::billed_hours(const int time) {
+        // every started hour is paid in full
+        return (time + 59) / 60;
+    }
+
+    void Club::charge_session(const std::string &client, const int table, const int time) {
+        const int hours = billed_hours(time);
+        const int amount = hours * hour_cost;
+        cumulative_time[table] += time;
+        revenue[table] += amount;
+        // a sit of 0 minutes is not billed, so it is neither a session nor a used table
+        if (!keeps_ledger || hours == 0) {
+            return;
+        }
+        // every session is rounded up on its own, as the per-table revenue is
+        const int id = client_id(client);
+        if (id >= static_cast<int>(ledger_sessions.size())) {
+            ledger_sessions.resize(id + 1);
+            ledger_hours.resize(id + 1);
+            ledger_amount.resize(id + 1);
+        }
+        ledger_sessions[id]++;
+        ledger_hours[id] += hours;
+        ledger_amount[id] += amount;
+        session_client.push_back(id);
+        session_table.push_back(table);
+    }
+
+    int Club::client_id(const std::string &client) {
+        const auto [it, is_new] = client_ids.try_emplace(client, static_cast<int>(client_names.size()));
+        if (is_new) {
+            client_names.push_back(client);
+        }
+        return it->second;
+    }
+
+    std::vector<std::pair<int, int> > Club::ledger_tables() const {
+        std::vector<std::pair<int, int> > tables;
+        tables.reserve(session_client.size());
+        for (std::size_t i = 0; i < session_client.size(); i++) {
+            tables.emplace_back(session_client[i], session_table[i]);
+        }
+        std::sort(tables.begin(), tables.end());
+        tables.erase(std::unique(tables.begin(), tables.end()), tables.end());
+        return tables;
     }
 
     void Club::handle_events() {
-        bool kik_out_is_handled = false;
         for (auto &event: events) {
             if (!event) continue;
-            if (event->get_time() > finish_time && !kik_out_is_handled) {
-                handle_kick_out();
-                kik_out_is_handled = true;
-            }
-            auto &stored_event = resulting_events.emplace_back(std::move(event));
-
-            switch (stored_event->get_type()) {
-                case 1:
-                    handle_client_come(dynamic_cast<EventClientCome &>(*stored_event));
-                    break;
-                case 2:
-                    handle_client_sit(dynamic_cast<EventClientSit &>(*stored_event));
-                    break;
-                case 3:
-                    handle_client_wait(dynamic_cast<EventClientWait &>(*stored_event));
-                    break;
-                case 4:
-                    handle_client_leave(dynamic_cast<EventClientLeave &>(*stored_event));
-                    break;
-            }
+            handle_event(std::move(event));
+        }
+        if (!kick_out_is_handled) {
+            handle_kick_out();
+            kick_out_is_handled = true;
         }
-        if (!kik_out_is_handled) {
+    }
+
+    void Club::handle_event(std::unique_ptr<Event> event) {
+        if (event->get_time() > finish_time && !kick_out_is_handled) {
             handle_kick_out();
+            kick_out_is_handled = true;
+        }
+        auto &stored_event = resulting_events.emplace_back(std::move(event));
+
+        switch (stored_event->get_type()) {
+            case 1:
+                handle_client_come(dynamic_cast<EventClientCome &>(*stored_event));
+                break;
+            case 2:
+                handle_client_sit(dynamic_cast<EventClientSit &>(*stored_event));
+                break;
+            case 3:
+                handle_client_wait(dynamic_cast<EventClientWait &>(*stored_event));
+                break;
+            case 4:
+                handle_client_leave(dynamic_cast<EventClientLeave &>(*stored_event));
+                break;
         }
     }
 
@@ -201,8 +321,7 @@ namespace club {
             sitting_client[old_table] = "";
             sitting_start_time[old_table] = -1;
             sitting_table[client] = -1;
-            cumulative_time[old_table] += diff_time;
-            revenue[old_table] += charge_money(diff_time);
+            charge_session(client, old_table, diff_time);
             empty_tables++;
         }
 
@@ -254,8 +373,7 @@ namespace club {
             const int diff_time = event.time - old_start_time;
             sitting_client[cur_table] = "";
             sitting_start_time[cur_table] = -1;
-            cumulative_time[cur_table] += diff_time;
-            revenue[cur_table] += charge_money(diff_time);
+            charge_session(client, cur_table, diff_time);
         }
         const auto it = std::find(queue.begin(), queue.end(), client);
         if (it != queue.end()) {
@@ -289,8 +407,7 @@ namespace club {
                 sitting_client[table] = "";
                 sitting_start_time[table] = -1;
                 sitting_table[client] = -1;
-                cumulative_time[table] += diff_time;
-                revenue[table] += charge_money(diff_time);
+                charge_session(client, table, diff_time);
             }
             resulting_events.emplace_back(std::make_unique<EventClientKicked>(finish_time, client));
         }
@@ -305,6 +422,145 @@ namespace club {
         for (int i = 0; i < total_tables; i++) {
             out << i + 1 << " " << revenue[i] << " " << format_time(cumulative_time[i]) << std::endl;
         }
+        if (keeps_ledger) {
+            print_ledger();
+        }
+    }
+
+    // One line per billed client, ordered by name: name, sessions, billed hours, amount, tables used
+    void Club::print_ledger() const {
+        std::vector<std::string> tables_used(ledger_sessions.size());
+        for (const auto &[id, table]: ledger_tables()) {
+            tables_used[id] += (tables_used[id].empty() ? "" : ",") + std::to_string(table + 1);
+        }
+        std::vector<int> billed;
+        for (int id = 0; id < static_cast<int>(ledger_sessions.size()); id++) {
+            if (ledger_sessions[id] > 0) {
+                billed.push_back(id);
+            }
+        }
+        std::sort(billed.begin(), billed.end(), [this](const int a, const int b) {
+            return client_names[a] < client_names[b];
+        });
+        for (const int id: billed) {
+            out << client_names[id] << " " << ledger_sessions[id] << " " << ledger_hours[id] << " "
+                    << ledger_amount[id] << " " << tables_used[id] << std::endl;
+        }
+    }
+
+    // Columns:
+    //   club.config       int32[4]  tables, opening and closing time, hour cost (empty for a corrupted input)
+    //   event.*           one row per transcript line: time (minutes), type, client (index into
+    //                     client.name or -1), table (1-based or 0) and error (index into error.name)
+    //   client.name       dictionary of client names, error.name - of error texts (entry 0 is empty)
+    //   table.revenue     int64 per table, table.occupancy - int32 minutes per table
+    //   input.error_line  int32[1] number of the line that stopped parsing or 0,
+    //                     input.error_text holds that line
+    //   ledger.*          only with the ledger enabled, one row per billed client: client, sessions,
+    //                     hours, amount (int64) and tables used, ledger.tables[table_offsets[i]..table_offsets[i + 1])
+    void Club::print_columns() {
+        static const std::vector<std::string> error_names = {
+            "", "YouShallNotPass", "NotOpenYet", "PlaceIsBusy", "ClientUnknown", "ICanWaitNoLonger!"
+        };
+        const bool is_valid = !is_corrupted && line_num >= 3;
+
+        std::vector<std::int32_t> times;
+        std::vector<std::uint8_t> types;
+        std::vector<std::int32_t> clients;
+        std::vector<std::int32_t> tables;
+        std::vector<std::uint8_t> errors;
+        const auto add_event = [&](const Event &event, const std::string &client, const int table,
+                                   const std::uint8_t error) {
+            const int id = client.empty() ? -1 : client_id(client);
+            times.push_back(event.get_time());
+            types.push_back(static_cast<std::uint8_t>(event.get_type()));
+            clients.push_back(id);
+            tables.push_back(table + 1);
+            errors.push_back(error);
+        };
+        if (is_valid) {
+            for (const auto &event: resulting_events) {
+                switch (event->get_type()) {
+                    case 1:
+                        add_event(*event, dynamic_cast<const EventClientCome &>(*event).client_name, -1, 0);
+                        break;
+                    case 2: {
+                        const auto &sit = dynamic_cast<const EventClientSit &>(*event);
+                        add_event(*event, sit.client_name, sit.table, 0);
+                        break;
+                    }
+                    case 3:
+                        add_event(*event, dynamic_cast<const EventClientWait &>(*event).client_name, -1, 0);
+                        break;
+                    case 4:
+                        add_event(*event, dynamic_cast<const EventClientLeave &>(*event).client_name, -1, 0);
+                        break;
+                    case 11:
+                        add_event(*event, dynamic_cast<const EventClientKicked &>(*event).client_name, -1, 0);
+                        break;
+                    case 12: {
+                        const auto &sat = dynamic_cast<const EventClientSat &>(*event);
+                        add_event(*event, sat.client_name, sat.table, 0);
+                        break;
+                    }
+                    case 13: {
+                        const auto &error = dynamic_cast<const EventError &>(*event).error;
+                        const auto it = std::find(error_names.begin(), error_names.end(), error);
+                        add_event(*event, "", -1, static_cast<std::uint8_t>(it - error_names.begin()));
+                        break;
+                    }
+                }
+            }
+        }
+
+        ColumnarWriter writer;
+        writer.add("club.config", is_valid
+                                      ? std::vector<std::int32_t>{total_tables, start_time, finish_time, hour_cost}
+                                      : std::vector<std::int32_t>{});
+        writer.add("event.time", times);
+        writer.add("event.type", types);
+        writer.add("event.client", clients);
+        writer.add("event.table", tables);
+        writer.add("event.error", errors);
+        writer.add_strings("client.name", client_names);
+        writer.add_strings("error.name", error_names);
+        writer.add("table.revenue", std::vector<std::int64_t>(revenue.begin(), revenue.end()));
+        writer.add("table.occupancy", std::vector<std::int32_t>(cumulative_time.begin(), cumulative_time.end()));
+        if (keeps_ledger) {
+            std::vector<std::int32_t> ledger_client;
+            std::vector<std::int32_t> sessions;
+            std::vector<std::int32_t> hours;
+            std::vector<std::int64_t> amount;
+            std::vector<std::uint32_t> table_offsets = {0};
+            std::vector<std::int32_t> tables_used;
+            const auto tables = ledger_tables();
+            auto table_it = tables.begin();
+            for (int id = 0; id < static_cast<int>(ledger_sessions.size()); id++) {
+                for (; table_it != tables.end() && table_it->first == id; ++table_it) {
+                    tables_used.push_back(table_it->second + 1);
+                }
+                if (ledger_sessions[id] == 0) {
+                    continue;
+                }
+                ledger_client.push_back(id);
+                sessions.push_back(ledger_sessions[id]);
+                hours.push_back(ledger_hours[id]);
+                amount.push_back(ledger_amount[id]);
+                table_offsets.push_back(static_cast<std::uint32_t>(tables_used.size()));
+            }
+            writer.add("ledger.client", ledger_client);
+            writer.add("ledger.sessions", sessions);
+            writer.add("ledger.hours", hours);
+            writer.add("ledger.amount", amount);
+            writer.add("ledger.table_offsets", table_offsets);
+            writer.add("ledger.tables", tables_used);
+        }
+        writer.add("input.error_line", std::vector<std::int32_t>{
+                       is_valid ? 0 : is_corrupted ? bad_line_num : line_num + 1
+                   });
+        writer.add("input.error_text", std::vector<char>(bad_line.begin(), bad_line.end()));
+        writer.write(out);
+        out.flush();
     }
 
     bool Club::parse_positive_int(const std::string &sint, int &result) {
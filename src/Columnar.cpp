@@ -0,0 +1,140 @@
+#include "Club/Columnar.h"
+
+#include <cstring>
+#include <utility>
+
+namespace club {
+    using columnar::ColumnEntry;
+    using columnar::FileHeader;
+
+    namespace {
+        constexpr std::uint64_t alignment = 8;
+
+        std::uint64_t align_up(const std::uint64_t offset) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        std::size_t type_size(const columnar::Type type) {
+            switch (type) {
+                case columnar::Type::Int32:
+                case columnar::Type::UInt32:
+                    return 4;
+                case columnar::Type::Int64:
+                    return 8;
+                case columnar::Type::UInt8:
+                case columnar::Type::Char:
+                    return 1;
+            }
+            return 0;
+        }
+    }
+
+    void ColumnarWriter::add(std::string name, const columnar::Type type, const std::uint64_t count,
+                             const std::string_view bytes) {
+        if (name.size() >= sizeof(ColumnEntry::name)) {
+            throw std::invalid_argument("column name is too long: " + name);
+        }
+        columns.push_back({std::move(name), type, count, std::string(bytes)});
+    }
+
+    void ColumnarWriter::add_strings(const std::string &name, const std::vector<std::string> &values) {
+        std::vector<std::uint32_t> offsets;
+        std::vector<char> chars;
+        offsets.reserve(values.size() + 1);
+        offsets.push_back(0);
+        for (const auto &value: values) {
+            chars.insert(chars.end(), value.begin(), value.end());
+            offsets.push_back(static_cast<std::uint32_t>(chars.size()));
+        }
+        add(name + ".offsets", offsets);
+        add(name + ".data", chars);
+    }
+
+    void ColumnarWriter::write(std::ostream &out) const {
+        FileHeader header{};
+        std::memcpy(header.magic, columnar::magic, sizeof(header.magic));
+        header.column_count = static_cast<std::uint32_t>(columns.size());
+
+        std::vector<ColumnEntry> entries(columns.size());
+        std::uint64_t offset = sizeof(FileHeader) + entries.size() * sizeof(ColumnEntry);
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            offset = align_up(offset);
+            std::memcpy(entries[i].name, columns[i].name.data(), columns[i].name.size());
+            entries[i].type = columns[i].type;
+            entries[i].count = columns[i].count;
+            entries[i].offset = offset;
+            offset += columns[i].bytes.size();
+        }
+
+        std::uint64_t written = 0;
+        const auto put = [&](const void *bytes, const std::size_t size) {
+            out.write(static_cast<const char *>(bytes), static_cast<std::streamsize>(size));
+            written += size;
+        };
+        put(&header, sizeof(header));
+        put(entries.data(), entries.size() * sizeof(ColumnEntry));
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            static constexpr char padding[alignment] = {};
+            put(padding, entries[i].offset - written);
+            put(columns[i].bytes.data(), columns[i].bytes.size());
+        }
+    }
+
+    ColumnarReader::ColumnarReader(const std::string_view data) : data(data) {
+        if (reinterpret_cast<std::uintptr_t>(data.data()) % alignment != 0) {
+            throw std::runtime_error("columnar data is not aligned");
+        }
+        if (data.size() < sizeof(FileHeader)) {
+            throw std::runtime_error("columnar data is truncated");
+        }
+        const auto &header = *reinterpret_cast<const FileHeader *>(data.data());
+        if (std::memcmp(header.magic, columnar::magic, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("not a columnar club result");
+        }
+        if ((data.size() - sizeof(FileHeader)) / sizeof(ColumnEntry) < header.column_count) {
+            throw std::runtime_error("columnar data is truncated");
+        }
+        entries = {reinterpret_cast<const ColumnEntry *>(data.data() + sizeof(FileHeader)), header.column_count};
+        for (const auto &entry: entries) {
+            const std::size_t size = type_size(entry.type);
+            if (size == 0 || entry.offset % alignment != 0 || entry.offset > data.size()
+                || (data.size() - entry.offset) / size < entry.count) {
+                throw std::runtime_error("columnar data is malformed");
+            }
+        }
+    }
+
+    const ColumnEntry *ColumnarReader::lookup(const std::string_view name) const {
+        for (const auto &entry: entries) {
+            if (name == std::string_view(entry.name, strnlen(entry.name, sizeof(entry.name)))) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    const ColumnEntry &ColumnarReader::find(const std::string_view name) const {
+        const ColumnEntry *entry = lookup(name);
+        if (!entry) {
+            throw std::runtime_error("no column " + std::string(name));
+        }
+        return *entry;
+    }
+
+    bool ColumnarReader::has(const std::string_view name) const {
+        return lookup(name) != nullptr;
+    }
+
+    std::vector<std::string_view> ColumnarReader::strings(const std::string &name) const {
+        const auto offsets = column<std::uint32_t>(name + ".offsets");
+        const auto chars = column<char>(name + ".data");
+        std::vector<std::string_view> values;
+        for (std::size_t i = 0; i + 1 < offsets.size(); i++) {
+            if (offsets[i] > offsets[i + 1] || offsets[i + 1] > chars.size()) {
+                throw std::runtime_error("string column " + name + " is malformed");
+            }
+            values.emplace_back(chars.data() + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        return values;
+    }
+} // club
@@ -0,0 +1,381 @@
+#include "Club/Compression.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef CLUB_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef CLUB_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace club {
+    namespace {
+        constexpr std::size_t block_size = 1 << 18;
+        constexpr unsigned char gzip_magic[] = {0x1f, 0x8b};
+        constexpr unsigned char zstd_magic[] = {0x28, 0xb5, 0x2f, 0xfd};
+    }
+
+    // One direction of one compression format, fed with whatever input is at hand
+    class Codec {
+    public:
+        struct Step {
+            std::size_t consumed;
+            std::size_t produced;
+            // decoder: the input consumed so far ends exactly at the end of a compressed stream,
+            // encoder: the compressed stream is complete
+            bool is_end;
+        };
+
+        virtual ~Codec() = default;
+
+        // is_last is only meaningful for encoders: no input will follow the given one
+        virtual Step step(const char *in, std::size_t in_size, char *out, std::size_t out_size, bool is_last) = 0;
+    };
+
+    namespace {
+#ifdef CLUB_HAVE_ZLIB
+        class GzipDecoder : public Codec {
+            z_stream stream{};
+            bool is_end = false;
+
+        public:
+            GzipDecoder() {
+                // 15 + 32: maximum window, accept both gzip and zlib headers
+                if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+                    throw std::runtime_error("gzip: can't initialize decoder");
+                }
+            }
+
+            ~GzipDecoder() override {
+                inflateEnd(&stream);
+            }
+
+            Step step(const char *in, const std::size_t in_size, char *out, const std::size_t out_size,
+                      bool) override {
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+                stream.avail_in = static_cast<uInt>(in_size);
+                stream.next_out = reinterpret_cast<Bytef *>(out);
+                stream.avail_out = static_cast<uInt>(out_size);
+                const int rc = inflate(&stream, Z_NO_FLUSH);
+                const std::size_t consumed = in_size - stream.avail_in;
+                const std::size_t produced = out_size - stream.avail_out;
+                if (rc == Z_STREAM_END) {
+                    // several gzip members may be concatenated, as "cat a.gz b.gz" does
+                    inflateReset(&stream);
+                    is_end = true;
+                } else if (rc == Z_OK) {
+                    is_end = is_end && consumed == 0 && produced == 0;
+                } else if (rc != Z_BUF_ERROR) {
+                    throw std::runtime_error(std::string("gzip: ") + (stream.msg ? stream.msg : "corrupted input"));
+                }
+                return {consumed, produced, is_end};
+            }
+        };
+
+        class GzipEncoder : public Codec {
+            z_stream stream{};
+
+        public:
+            GzipEncoder() {
+                // 15 + 16: maximum window with a gzip header
+                if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    throw std::runtime_error("gzip: can't initialize encoder");
+                }
+            }
+
+            ~GzipEncoder() override {
+                deflateEnd(&stream);
+            }
+
+            Step step(const char *in, const std::size_t in_size, char *out, const std::size_t out_size,
+                      const bool is_last) override {
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+                stream.avail_in = static_cast<uInt>(in_size);
+                stream.next_out = reinterpret_cast<Bytef *>(out);
+                stream.avail_out = static_cast<uInt>(out_size);
+                const int rc = deflate(&stream, is_last ? Z_FINISH : Z_NO_FLUSH);
+                if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+                    throw std::runtime_error("gzip: compression failed");
+                }
+                return {in_size - stream.avail_in, out_size - stream.avail_out, rc == Z_STREAM_END};
+            }
+        };
+#endif
+
+#ifdef CLUB_HAVE_ZSTD
+        class ZstdDecoder : public Codec {
+            ZSTD_DStream *stream;
+            bool is_end = false;
+
+        public:
+            ZstdDecoder() : stream(ZSTD_createDStream()) {
+                if (!stream || ZSTD_isError(ZSTD_initDStream(stream))) {
+                    ZSTD_freeDStream(stream);
+                    throw std::runtime_error("zstd: can't initialize decoder");
+                }
+            }
+
+            ~ZstdDecoder() override {
+                ZSTD_freeDStream(stream);
+            }
+
+            Step step(const char *in, const std::size_t in_size, char *out, const std::size_t out_size,
+                      bool) override {
+                ZSTD_inBuffer input{in, in_size, 0};
+                ZSTD_outBuffer output{out, out_size, 0};
+                const std::size_t rc = ZSTD_decompressStream(stream, &output, &input);
+                if (ZSTD_isError(rc)) {
+                    throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(rc));
+                }
+                if (input.pos > 0 || output.pos > 0) {
+                    // 0 means a frame is fully decoded and flushed
+                    is_end = rc == 0;
+                }
+                return {input.pos, output.pos, is_end};
+            }
+        };
+
+        class ZstdEncoder : public Codec {
+            ZSTD_CCtx *context;
+
+        public:
+            ZstdEncoder() : context(ZSTD_createCCtx()) {
+                if (!context) {
+                    throw std::runtime_error("zstd: can't initialize encoder");
+                }
+            }
+
+            ~ZstdEncoder() override {
+                ZSTD_freeCCtx(context);
+            }
+
+            Step step(const char *in, const std::size_t in_size, char *out, const std::size_t out_size,
+                      const bool is_last) override {
+                ZSTD_inBuffer input{in, in_size, 0};
+                ZSTD_outBuffer output{out, out_size, 0};
+                const std::size_t remaining = ZSTD_compressStream2(context, &output, &input,
+                                                                   is_last ? ZSTD_e_end : ZSTD_e_continue);
+                if (ZSTD_isError(remaining)) {
+                    throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(remaining));
+                }
+                return {input.pos, output.pos, is_last && remaining == 0};
+            }
+        };
+#endif
+
+        std::unique_ptr<Codec> make_codec(const Compression compression, [[maybe_unused]] const bool is_encoder) {
+            switch (compression) {
+#ifdef CLUB_HAVE_ZLIB
+                case Compression::Gzip:
+                    if (is_encoder) {
+                        return std::make_unique<GzipEncoder>();
+                    }
+                    return std::make_unique<GzipDecoder>();
+#endif
+#ifdef CLUB_HAVE_ZSTD
+                case Compression::Zstd:
+                    if (is_encoder) {
+                        return std::make_unique<ZstdEncoder>();
+                    }
+                    return std::make_unique<ZstdDecoder>();
+#endif
+                default:
+                    throw std::runtime_error("this compression format is not supported by the build");
+            }
+        }
+    }
+
+    bool is_supported(const Compression compression) {
+        switch (compression) {
+            case Compression::None:
+                return true;
+            case Compression::Gzip:
+#ifdef CLUB_HAVE_ZLIB
+                return true;
+#else
+                return false;
+#endif
+            case Compression::Zstd:
+#ifdef CLUB_HAVE_ZSTD
+                return true;
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    bool parse_compression(const std::string_view name, Compression &result) {
+        if (name == "none") {
+            result = Compression::None;
+        } else if (name == "gzip") {
+            result = Compression::Gzip;
+        } else if (name == "zstd") {
+            result = Compression::Zstd;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    Compression detect_compression(const std::string_view prefix) {
+        const auto starts_with = [&](const unsigned char *expected, const std::size_t expected_size) {
+            return prefix.size() >= expected_size && std::memcmp(prefix.data(), expected, expected_size) == 0;
+        };
+        if (starts_with(gzip_magic, sizeof(gzip_magic))) {
+            return Compression::Gzip;
+        }
+        if (starts_with(zstd_magic, sizeof(zstd_magic))) {
+            return Compression::Zstd;
+        }
+        return Compression::None;
+    }
+
+    DecompressingStream::Buffer::Buffer(std::streambuf &source, const Compression compression)
+        : source(source), compression(compression),
+          codec(compression == Compression::None ? nullptr : make_codec(compression, false)),
+          in(new char[block_size]), out(new char[block_size]) {
+    }
+
+    DecompressingStream::Buffer::Buffer(std::streambuf &source)
+        : Buffer(source, Compression::None) {
+        // sgetn keeps reading until it has all the bytes, a pipe may deliver them one by one
+        in_end = static_cast<std::size_t>(source.sgetn(in.get(), sizeof(zstd_magic)));
+        is_source_exhausted = in_end == 0;
+        compression = detect_compression({in.get(), in_end});
+        if (compression != Compression::None) {
+            codec = make_codec(compression, false);
+        }
+    }
+
+    DecompressingStream::Buffer::~Buffer() = default;
+
+    DecompressingStream::Buffer::int_type DecompressingStream::Buffer::pass_through() {
+        if (in_begin < in_end) {
+            // the bytes read for detection come first
+            setg(in.get() + in_begin, in.get() + in_begin, in.get() + in_end);
+            in_begin = in_end;
+            return traits_type::to_int_type(*gptr());
+        }
+        const std::streamsize got = is_source_exhausted ? 0 : source.sgetn(out.get(), block_size);
+        if (got <= 0) {
+            is_source_exhausted = true;
+            return traits_type::eof();
+        }
+        setg(out.get(), out.get(), out.get() + got);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    DecompressingStream::Buffer::int_type DecompressingStream::Buffer::underflow() {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (!codec) {
+            return pass_through();
+        }
+        while (true) {
+            if (in_begin == in_end && !is_source_exhausted) {
+                in_begin = 0;
+                in_end = static_cast<std::size_t>(source.sgetn(in.get(), block_size));
+                is_source_exhausted = in_end == 0;
+            }
+            const auto [consumed, produced, is_end] = codec->step(
+                in.get() + in_begin, in_end - in_begin, out.get(), block_size, is_source_exhausted);
+            in_begin += consumed;
+            if (produced > 0) {
+                setg(out.get(), out.get(), out.get() + produced);
+                return traits_type::to_int_type(*gptr());
+            }
+            if (is_source_exhausted) {
+                if (!is_end) {
+                    throw std::runtime_error("compressed input is truncated");
+                }
+                return traits_type::eof();
+            }
+            if (consumed == 0 && in_begin < in_end) {
+                throw std::runtime_error("compressed input is corrupted");
+            }
+        }
+    }
+
+    DecompressingStream::DecompressingStream(std::istream &source, const Compression compression)
+        : std::istream(nullptr), buffer(*source.rdbuf(), compression) {
+        rdbuf(&buffer);
+        // let decoding errors reach the caller instead of looking like the end of input
+        exceptions(std::ios::badbit);
+    }
+
+    DecompressingStream::DecompressingStream(std::istream &source)
+        : std::istream(nullptr), buffer(*source.rdbuf()) {
+        rdbuf(&buffer);
+        exceptions(std::ios::badbit);
+    }
+
+    CompressingStream::Buffer::Buffer(std::ostream &sink, const Compression compression)
+        : sink(sink), codec(make_codec(compression, true)),
+          in(new char[block_size]), out(new char[block_size]) {
+        setp(in.get(), in.get() + block_size);
+    }
+
+    CompressingStream::Buffer::~Buffer() {
+        try {
+            finish();
+        } catch (...) {
+        }
+    }
+
+    void CompressingStream::Buffer::compress(const bool is_last) {
+        const char *data = pbase();
+        std::size_t size = pptr() - pbase();
+        while (true) {
+            const auto [consumed, produced, is_end] = codec->step(data, size, out.get(), block_size, is_last);
+            data += consumed;
+            size -= consumed;
+            sink.write(out.get(), static_cast<std::streamsize>(produced));
+            if (is_last ? is_end : size == 0) {
+                break;
+            }
+        }
+        setp(in.get(), in.get() + block_size);
+    }
+
+    CompressingStream::Buffer::int_type CompressingStream::Buffer::overflow(const int_type c) {
+        if (is_finished) {
+            return traits_type::eof();
+        }
+        compress(false);
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int CompressingStream::Buffer::sync() {
+        // compressing every flushed line separately would ruin the ratio
+        return 0;
+    }
+
+    void CompressingStream::Buffer::finish() {
+        if (is_finished) {
+            return;
+        }
+        is_finished = true;
+        compress(true);
+        setp(nullptr, nullptr);
+        sink.flush();
+    }
+
+    CompressingStream::CompressingStream(std::ostream &sink, const Compression compression)
+        : std::ostream(nullptr), buffer(sink, compression) {
+        rdbuf(&buffer);
+    }
+
+    void CompressingStream::finish() {
+        buffer.finish();
+    }
+} // club
@@ -0,0 +1,198 @@
+#include "Club/EventRouter.h"
+#include "Club/Club.h"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace club {
+    namespace {
+        constexpr std::size_t queue_capacity = 1 << 14;
+        constexpr std::string_view result_command = "RESULT ";
+        constexpr std::string_view close_command = "CLOSE ";
+
+        void pin_to_core([[maybe_unused]] std::thread &thread, [[maybe_unused]] const unsigned core) {
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(core, &set);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+        }
+    }
+
+    struct EventRouter::Shard {
+        struct Venue {
+            std::ostringstream result;
+            Club club = Club::live(result);
+            // set once handling a line of the venue threw, the rest of its day is then ignored
+            std::string error;
+        };
+
+        SpscQueue<std::string> queue{queue_capacity};
+        std::unordered_map<std::string, std::unique_ptr<Venue> > venues;
+        std::thread worker;
+    };
+
+    EventRouter::EventRouter(unsigned shards, std::ostream &out) : out(out) {
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        if (shards == 0) {
+            shards = cores;
+        }
+        for (unsigned i = 0; i < shards; i++) {
+            auto &shard = this->shards.emplace_back(std::make_unique<Shard>());
+            shard->worker = std::thread(&EventRouter::work, this, std::ref(*shard));
+            pin_to_core(shard->worker, i % cores);
+        }
+    }
+
+    EventRouter::~EventRouter() {
+        stop();
+    }
+
+    std::string_view EventRouter::venue_of(std::string_view line) {
+        if (line.starts_with(result_command)) {
+            line.remove_prefix(result_command.size());
+        } else if (line.starts_with(close_command)) {
+            line.remove_prefix(close_command.size());
+        } else if (line == result_command.substr(0, result_command.size() - 1)
+                   || line == close_command.substr(0, close_command.size() - 1)) {
+            // a command without a venue, not a venue named after the command
+            return {};
+        }
+        return line.substr(0, line.find(' '));
+    }
+
+    bool EventRouter::route(std::string line) {
+        // an empty line is the stop signal for the workers
+        const std::string_view venue = venue_of(line);
+        if (venue.empty()) {
+            return false;
+        }
+        Shard &shard = *shards[std::hash<std::string_view>{}(venue) % shards.size()];
+        while (!shard.queue.try_push(std::move(line))) {
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    void EventRouter::serve(std::istream &in, std::ostream &err) {
+        std::string line;
+        int line_num = 0;
+        while (std::getline(in, line)) {
+            line_num++;
+            if (!line.empty() && !route(line)) {
+                err << "Line " << line_num << " names no venue, skipped: " << line << std::endl;
+            }
+        }
+        stop();
+    }
+
+    void EventRouter::stop() {
+        if (is_stopped) {
+            return;
+        }
+        is_stopped = true;
+        for (const auto &shard: shards) {
+            while (!shard->queue.try_push(std::string())) {
+                std::this_thread::yield();
+            }
+        }
+        for (const auto &shard: shards) {
+            shard->worker.join();
+        }
+    }
+
+    void EventRouter::work(Shard &shard) {
+        std::string line;
+        while (true) {
+            if (!shard.queue.try_pop(line)) {
+                shard.queue.wait();
+                continue;
+            }
+            if (line.empty()) {
+                return;
+            }
+            try {
+                handle(shard, line);
+            } catch (const std::exception &e) {
+                // e.g. out of memory while emitting, keep serving the other lines
+                std::cerr << "Error: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    void EventRouter::handle(Shard &shard, std::string &line) {
+        // a venue whose input makes the club throw fails alone, the process and other venues go on
+        const auto guarded = [](Shard::Venue &state, const auto &step) {
+            if (!state.error.empty()) {
+                return;
+            }
+            try {
+                step();
+            } catch (const std::exception &e) {
+                state.error = e.what();
+            } catch (...) {
+                state.error = "Unknown error occurred";
+            }
+        };
+
+        const bool is_result = line.starts_with(result_command);
+        const bool is_close = line.starts_with(close_command);
+        if (is_result || is_close) {
+            const std::string venue(venue_of(line));
+            const auto it = shard.venues.find(venue);
+            if (it == shard.venues.end()) {
+                // nothing was fed, so report it like an empty club
+                std::ostringstream result;
+                Club::live(result).report();
+                emit(venue, result.str());
+                return;
+            }
+            Shard::Venue &state = *it->second;
+            guarded(state, [&] {
+                if (is_close) {
+                    state.club.close();
+                }
+                state.result.str("");
+                state.club.report();
+            });
+            // reported like a batch run that failed with this error
+            emit(venue, state.error.empty() ? state.result.str() : "Error: " + state.error + "\n");
+            if (is_close) {
+                shard.venues.erase(it);
+            }
+            return;
+        }
+
+        const std::size_t space = line.find(' ');
+        std::string venue = line.substr(0, space);
+        line.erase(0, space == std::string::npos ? line.size() : space + 1);
+        auto &state = shard.venues[std::move(venue)];
+        if (!state) {
+            state = std::make_unique<Shard::Venue>();
+        }
+        guarded(*state, [&] {
+            state->club.feed(line);
+        });
+    }
+
+    void EventRouter::emit(const std::string_view venue, const std::string &result) {
+        std::string tagged;
+        std::istringstream lines(result);
+        std::string line;
+        while (std::getline(lines, line)) {
+            tagged.append(venue).append(" ").append(line).append("\n");
+        }
+        const std::lock_guard lock(out_mutex);
+        out << tagged << std::flush;
+    }
+} // club
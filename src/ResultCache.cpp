@@ -0,0 +1,254 @@
+#include "Club/ResultCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CLUB_SHARED_COUNTERS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace club {
+    namespace fs = std::filesystem;
+
+    namespace {
+        struct Candidate {
+            fs::file_time_type time;
+            std::uintmax_t size;
+            fs::path path;
+        };
+
+        std::vector<Candidate> list_entries(const fs::path &dir) {
+            std::vector<Candidate> entries;
+            std::error_code ec;
+            for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+                if (it->path().extension() != ".out") {
+                    continue;
+                }
+                // entries may disappear under us, evicted by another worker
+                std::error_code size_ec;
+                std::error_code time_ec;
+                const std::uintmax_t size = it->file_size(size_ec);
+                const fs::file_time_type time = it->last_write_time(time_ec);
+                if (size_ec || time_ec) {
+                    continue;
+                }
+                entries.push_back({time, size, it->path()});
+            }
+            return entries;
+        }
+    }
+
+    ResultCache::ResultCache(fs::path dir, const std::uintmax_t max_bytes)
+        : dir(std::move(dir)), max_bytes(max_bytes) {
+        fs::create_directories(this->dir);
+        if (!map_counters()) {
+            std::atomic_ref(counters->bytes).store(measure_size());
+        }
+    }
+
+    ResultCache::~ResultCache() {
+#ifdef CLUB_SHARED_COUNTERS
+        if (counters != &local_counters) {
+            munmap(counters, sizeof(Counters));
+        }
+#endif
+    }
+
+    bool ResultCache::map_counters() {
+#ifdef CLUB_SHARED_COUNTERS
+        static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free);
+        const int fd = open((dir / "stats").c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st{};
+        const bool is_new = fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Counters));
+        // growing the file is harmless if another worker has just done the same
+        if (is_new && ftruncate(fd, sizeof(Counters)) != 0) {
+            close(fd);
+            return false;
+        }
+        void *mapped = mmap(nullptr, sizeof(Counters), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        counters = static_cast<Counters *>(mapped);
+        return !is_new;
+#else
+        return false;
+#endif
+    }
+
+    void ResultCache::add(std::uint64_t Counters::*counter, const std::uint64_t value) const {
+        std::atomic_ref(counters->*counter).fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::uint64_t ResultCache::load(std::uint64_t Counters::*counter) const {
+        return std::atomic_ref(counters->*counter).load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t ResultCache::measure_size() {
+        std::uint64_t total = 0;
+        for (const auto &entry: list_entries(dir)) {
+            total += entry.size;
+        }
+        return total;
+    }
+
+    std::uint64_t ResultCache::hash(const std::string_view data, const std::uint64_t seed) {
+        // FNV-1a: cheap enough to hash whole logs on every run, and can be continued block by block
+        std::uint64_t h = seed;
+        for (const unsigned char c: data) {
+            h ^= c;
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    std::string ResultCache::format_key(const std::uint64_t input_hash, const std::uint64_t input_size,
+                                        const std::string_view variant) {
+        // the input size is part of the key to make accidental collisions even less likely
+        char buf[64];
+        const int len = std::snprintf(buf, sizeof(buf), "%016llx-%llx-%016llx",
+                                      static_cast<unsigned long long>(input_hash),
+                                      static_cast<unsigned long long>(input_size),
+                                      static_cast<unsigned long long>(hash(variant)));
+        return {buf, static_cast<std::size_t>(len)};
+    }
+
+    std::string ResultCache::make_key(const std::string_view input, const std::string_view variant) {
+        return format_key(hash(input), input.size(), variant);
+    }
+
+    std::string ResultCache::make_key(std::istream &input, const std::string_view variant) {
+        constexpr std::size_t block_size = 1 << 18;
+        const std::unique_ptr<char[]> block(new char[block_size]);
+        std::uint64_t h = hash_seed;
+        std::uint64_t size = 0;
+        while (input) {
+            input.read(block.get(), block_size);
+            const auto got = static_cast<std::size_t>(input.gcount());
+            h = hash({block.get(), got}, h);
+            size += got;
+        }
+        return format_key(h, size, variant);
+    }
+
+    fs::path ResultCache::entry_path(const std::string &key) const {
+        return dir / (key + ".out");
+    }
+
+    bool ResultCache::lookup(const std::string &key, std::ostream &out) {
+        const fs::path path = entry_path(key);
+        std::ifstream entry(path, std::ios::binary);
+        if (!entry) {
+            add(&Counters::misses, 1);
+            return false;
+        }
+        if (entry.peek() != std::ifstream::traits_type::eof()) {
+            out << entry.rdbuf();
+        }
+        add(&Counters::hits, 1);
+
+        // refresh the entry for LRU; it may already be evicted by another worker
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+        return true;
+    }
+
+    ResultCache::Entry::Entry(ResultCache &cache, std::string key)
+        : cache(&cache), key(std::move(key)) {
+        // write under a unique name first, so concurrent workers never observe a partial entry
+        std::random_device rd;
+        tmp_path = cache.dir / (this->key + ".tmp-" + std::to_string(rd()));
+        file = std::make_unique<std::ofstream>(tmp_path, std::ios::binary | std::ios::trunc);
+    }
+
+    ResultCache::Entry::~Entry() {
+        if (file) {
+            file.reset();
+            std::error_code ec;
+            fs::remove(tmp_path, ec);
+        }
+    }
+
+    std::ostream &ResultCache::Entry::stream() {
+        return *file;
+    }
+
+    void ResultCache::Entry::commit() {
+        if (!file) {
+            return;
+        }
+        const auto size = static_cast<std::uint64_t>(file->tellp());
+        file->close();
+        const bool is_written = !file->fail();
+        file.reset();
+        std::error_code ec;
+        if (is_written) {
+            fs::rename(tmp_path, cache->entry_path(key), ec);
+        }
+        if (!is_written || ec) {
+            fs::remove(tmp_path, ec);
+            return;
+        }
+        cache->add(&Counters::bytes, size);
+        cache->evict();
+    }
+
+    ResultCache::Entry ResultCache::begin_store(const std::string &key) {
+        return {*this, key};
+    }
+
+    void ResultCache::store(const std::string &key, const std::string_view result) {
+        Entry entry = begin_store(key);
+        entry.stream().write(result.data(), static_cast<std::streamsize>(result.size()));
+        entry.commit();
+    }
+
+    void ResultCache::evict() {
+        // the directory is only scanned once the shared estimate goes over the limit
+        if (max_bytes == 0 || load(&Counters::bytes) <= max_bytes) {
+            return;
+        }
+        std::vector<Candidate> entries = list_entries(dir);
+        std::uint64_t total = 0;
+        for (const auto &entry: entries) {
+            total += entry.size;
+        }
+        if (total > max_bytes) {
+            std::sort(entries.begin(), entries.end(), [](const Candidate &a, const Candidate &b) {
+                return a.time < b.time;
+            });
+            for (const auto &entry: entries) {
+                if (total <= max_bytes) {
+                    break;
+                }
+                // another worker may be evicting the same entry concurrently
+                std::error_code ec;
+                if (fs::remove(entry.path, ec)) {
+                    add(&Counters::evictions, 1);
+                }
+                total -= entry.size;
+            }
+        }
+        // resynchronize the estimate with what is really on disk
+        std::atomic_ref(counters->bytes).store(total, std::memory_order_relaxed);
+    }
+
+    ResultCache::Stats ResultCache::stats() const {
+        return {load(&Counters::hits), load(&Counters::misses), load(&Counters::evictions)};
+    }
+} // club
@@ -1,16 +1,200 @@
+#include <charconv>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <streambuf>
+#include <string>
 
 #include "Club/Club.h"
+#include "Club/Compression.h"
+#include "Club/EventRouter.h"
+#include "Club/ResultCache.h"
 
-int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename>" << std::endl;
-        return 1;
+namespace {
+    struct Options {
+        std::string filename;
+        std::optional<std::string> cache_dir;
+        std::uintmax_t cache_limit = 0;
+        bool cache_stats = false;
+        club::OutputFormat format = club::OutputFormat::Text;
+        club::Compression compression = club::Compression::None;
+        bool ledger = false;
+        bool serve = false;
+        unsigned shards = 0;
+    };
+
+    void print_usage(const char *program) {
+        std::cerr << "Usage: " << program
+                << " [--format text|columnar] [--compress none|gzip|zstd] [--ledger]"
+                << " [--cache-dir <dir>] [--cache-limit <bytes>] [--cache-stats] <filename>" << std::endl;
+        std::cerr << "       " << program << " --serve [--shards <count>]" << std::endl;
+    }
+
+    // Plain decimal digits only: std::stoull would take "-1" and wrap it around
+    template<typename T>
+    bool parse_count(const std::string &text, T &result) {
+        const char *end = text.data() + text.size();
+        const auto [ptr, ec] = std::from_chars(text.data(), end, result);
+        return ec == std::errc() && ptr == end;
+    }
+
+    bool parse_options(const int argc, char *argv[], Options &options) {
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--format" && i + 1 < argc) {
+                const std::string format = argv[++i];
+                if (format == "text") {
+                    options.format = club::OutputFormat::Text;
+                } else if (format == "columnar") {
+                    options.format = club::OutputFormat::Columnar;
+                } else {
+                    return false;
+                }
+            } else if (arg == "--compress" && i + 1 < argc) {
+                if (!club::parse_compression(argv[++i], options.compression)) {
+                    return false;
+                }
+            } else if (arg == "--ledger") {
+                options.ledger = true;
+            } else if (arg == "--cache-dir" && i + 1 < argc) {
+                options.cache_dir = argv[++i];
+            } else if (arg == "--cache-limit" && i + 1 < argc) {
+                if (!parse_count(argv[++i], options.cache_limit)) {
+                    return false;
+                }
+            } else if (arg == "--cache-stats") {
+                options.cache_stats = true;
+            } else if (arg == "--serve") {
+                options.serve = true;
+            } else if (arg == "--shards" && i + 1 < argc) {
+                if (!parse_count(argv[++i], options.shards)) {
+                    return false;
+                }
+            } else if (arg.starts_with("--") || !options.filename.empty()) {
+                return false;
+            } else {
+                options.filename = arg;
+            }
+        }
+        return options.serve == options.filename.empty();
+    }
+
+    // Input is either a file name or a stream, the result goes to sink compressed if requested
+    template<typename Input>
+    void run_club(const Options &options, Input &input, std::ostream &sink) {
+        const auto run = [&](std::ostream &out) {
+            club::Club club(input, out);
+            if (options.ledger) {
+                club.enable_ledger();
+            }
+            club.run(options.format);
+        };
+        if (options.compression == club::Compression::None) {
+            run(sink);
+            return;
+        }
+        club::CompressingStream compressed(sink, options.compression);
+        run(compressed);
+        compressed.finish();
+    }
+
+    // Writes everything both to the console and to the cache entry being filled
+    class TeeBuffer : public std::streambuf {
+        std::ostream &first;
+        std::ostream &second;
+
+    public:
+        TeeBuffer(std::ostream &first, std::ostream &second) : first(first), second(second) {
+        }
+
+    protected:
+        int_type overflow(const int_type c) override {
+            if (traits_type::eq_int_type(c, traits_type::eof())) {
+                return traits_type::not_eof(c);
+            }
+            first.put(traits_type::to_char_type(c));
+            second.put(traits_type::to_char_type(c));
+            return first ? c : traits_type::eof();
+        }
+
+        std::streamsize xsputn(const char *s, const std::streamsize n) override {
+            first.write(s, n);
+            second.write(s, n);
+            return first ? n : 0;
+        }
+
+        int sync() override {
+            // the cache entry is flushed once, when it is committed
+            first.flush();
+            return first ? 0 : -1;
+        }
+    };
+
+    void run_cached(const Options &options) {
+        std::ifstream file(options.filename, std::ios::binary);
+        if (!file.is_open()) {
+            // nothing to cache, let the club report the missing input as usual
+            run_club(options, options.filename, std::cout);
+            return;
+        }
+        if (file.tellg() == std::streampos(-1)) {
+            // a pipe or FIFO can be read only once, it can't be both hashed and then parsed
+            if (options.cache_stats) {
+                std::cerr << "cache: input is not seekable, not cached" << std::endl;
+            }
+            run_club(options, file, std::cout);
+            return;
+        }
+        club::ResultCache cache(*options.cache_dir, options.cache_limit);
+
+        std::string variant(club::Club::engine_version);
+        variant += options.format == club::OutputFormat::Columnar ? " columnar" : " text";
+        if (options.ledger) {
+            variant += " ledger";
+        }
+        if (options.compression == club::Compression::Gzip) {
+            variant += " gzip";
+        } else if (options.compression == club::Compression::Zstd) {
+            variant += " zstd";
+        }
+        // the input is hashed and then parsed block by block, never held in memory as a whole
+        const std::string key = club::ResultCache::make_key(file, variant);
+
+        if (!cache.lookup(key, std::cout)) {
+            file.clear();
+            file.seekg(0);
+            club::ResultCache::Entry entry = cache.begin_store(key);
+            TeeBuffer tee_buffer(std::cout, entry.stream());
+            std::ostream tee(&tee_buffer);
+            run_club(options, file, tee);
+            tee.flush();
+            entry.commit();
+        }
+
+        if (options.cache_stats) {
+            const auto [hits, misses, evictions] = cache.stats();
+            std::cerr << "cache: hits=" << hits << " misses=" << misses
+                    << " evictions=" << evictions << std::endl;
+        }
     }
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
     try {
-        club::Club club(argv[1]);
-        club.run();
+        if (!parse_options(argc, argv, options)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (options.serve) {
+            club::EventRouter router(options.shards);
+            router.serve(std::cin);
+        } else if (options.cache_dir) {
+            run_cached(options);
+        } else {
+            run_club(options, options.filename, std::cout);
+        }
     } catch (const std::exception &e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "Club/ResultCache.h"
+
+namespace fs = std::filesystem;
+
+class ResultCacheTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / ("club_cache_" +
+                                           std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        fs::remove_all(dir);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir);
+    }
+};
+
+TEST_F(ResultCacheTest, MissThenHit) {
+    club::ResultCache cache(dir);
+    const std::string key = club::ResultCache::make_key("3\n09:00 19:00\n10\n", "1");
+
+    std::ostringstream miss;
+    EXPECT_FALSE(cache.lookup(key, miss));
+    EXPECT_TRUE(miss.str().empty());
+
+    cache.store(key, "09:00\n19:00\n");
+    std::ostringstream hit;
+    EXPECT_TRUE(cache.lookup(key, hit));
+    EXPECT_EQ(hit.str(), "09:00\n19:00\n");
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+}
+
+TEST_F(ResultCacheTest, StatsAreSharedThroughDirectory) {
+    club::ResultCache first(dir);
+    first.store("a", "09:00\n");
+    std::ostringstream out;
+    EXPECT_FALSE(first.lookup("b", out));
+
+    // another worker using the same directory
+    club::ResultCache second(dir);
+    EXPECT_TRUE(second.lookup("a", out));
+
+    const auto stats = second.stats();
+#if defined(__unix__) || defined(__APPLE__)
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(first.stats().hits, 1u);
+#else
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 0u);
+#endif
+}
+
+TEST_F(ResultCacheTest, KeyDependsOnInputAndVariant) {
+    const std::string key = club::ResultCache::make_key("input", "1");
+    EXPECT_EQ(key, club::ResultCache::make_key("input", "1"));
+    EXPECT_NE(key, club::ResultCache::make_key("inpuT", "1"));
+    EXPECT_NE(key, club::ResultCache::make_key("input", "2"));
+}
+
+TEST_F(ResultCacheTest, StreamedKeyMatchesWholeInput) {
+    std::string input;
+    for (int i = 0; input.size() < 1 << 20; i++) {
+        input += "09:00 1 client" + std::to_string(i) + "\n";
+    }
+    std::istringstream stream(input);
+    EXPECT_EQ(club::ResultCache::make_key(stream, "1"), club::ResultCache::make_key(input, "1"));
+}
+
+TEST_F(ResultCacheTest, UncommittedEntryIsDropped) {
+    club::ResultCache cache(dir);
+    {
+        auto entry = cache.begin_store("partial");
+        entry.stream() << "09:00\n";
+    }
+    std::ostringstream out;
+    EXPECT_FALSE(cache.lookup("partial", out));
+    for (const auto &file: fs::directory_iterator(dir)) {
+        EXPECT_EQ(file.path().filename(), "stats");
+    }
+}
+
+TEST_F(ResultCacheTest, EmptyResultIsCached) {
+    club::ResultCache cache(dir);
+    cache.store("empty", "");
+    std::ostringstream out;
+    EXPECT_TRUE(cache.lookup("empty", out));
+    EXPECT_TRUE(out.good());
+    EXPECT_TRUE(out.str().empty());
+}
+
+TEST_F(ResultCacheTest, EvictsLeastRecentlyUsed) {
+    club::ResultCache cache(dir, 20);
+    const auto now = fs::file_time_type::clock::now();
+
+    cache.store("a", "0123456789");
+    fs::last_write_time(dir / "a.out", now - std::chrono::hours(2));
+    cache.store("b", "0123456789");
+    fs::last_write_time(dir / "b.out", now - std::chrono::hours(1));
+
+    // touching "a" makes "b" the oldest entry
+    std::ostringstream out;
+    ASSERT_TRUE(cache.lookup("a", out));
+    cache.store("c", "0123456789");
+
+    EXPECT_TRUE(fs::exists(dir / "a.out"));
+    EXPECT_FALSE(fs::exists(dir / "b.out"));
+    EXPECT_TRUE(fs::exists(dir / "c.out"));
+    EXPECT_EQ(cache.stats().evictions, 1u);
+}
+
+#ifndef _WIN32
+// A pipe can't be hashed and parsed afterwards, so it is run as usual and not cached
+TEST_F(ResultCacheTest, PipedInputIsRunUncached) {
+    const fs::path input = fs::current_path() / "tests" / "data" / "legacy" / "test1.in";
+    ASSERT_TRUE(fs::exists(input));
+    const fs::path piped = fs::temp_directory_path() / "club_cache_piped.txt";
+    const fs::path plain = fs::temp_directory_path() / "club_cache_plain.txt";
+    const std::string run_piped = "cat \"" + input.string() + "\" | ./Club --cache-dir \"" + dir.string()
+                                  + "\" /dev/stdin > \"" + piped.string() + "\"";
+    const std::string run_plain = "./Club \"" + input.string() + "\" > \"" + plain.string() + "\"";
+    ASSERT_EQ(std::system(run_piped.c_str()), 0);
+    ASSERT_EQ(std::system(run_plain.c_str()), 0);
+
+    const auto read_file = [](const fs::path &path) {
+        std::ifstream file(path);
+        return std::string{std::istreambuf_iterator<char>(file), {}};
+    };
+    EXPECT_EQ(read_file(piped), read_file(plain));
+    fs::remove(piped);
+    fs::remove(plain);
+
+    if (fs::exists(dir)) {
+        for (const auto &file: fs::directory_iterator(dir)) {
+            EXPECT_NE(file.path().extension(), ".out") << file.path();
+        }
+    }
+    const club::ResultCache cache(dir);
+    EXPECT_EQ(cache.stats().misses, 0u);
+}
+#endif
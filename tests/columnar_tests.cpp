@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Club/Club.h"
+#include "Club/Columnar.h"
+
+namespace {
+    template<typename T>
+    std::vector<T> to_vector(std::span<const T> values) {
+        return {values.begin(), values.end()};
+    }
+
+    // std::string storage is 8-byte aligned, as is a mapped file
+    std::string run_columnar(const std::string &input) {
+        std::istringstream conf(input);
+        std::ostringstream out;
+        club::Club club(conf, out);
+        club.run(club::OutputFormat::Columnar);
+        return out.str();
+    }
+}
+
+TEST(ColumnarTest, WritesTranscriptAndSummary) {
+    const std::string data = run_columnar(
+        "2\n"
+        "09:00 20:00\n"
+        "10\n"
+        "08:00 1 client1\n"
+        "09:15 1 client1\n"
+        "09:30 2 client1 2\n"
+        "09:40 1 client2\n"
+        "09:45 2 client2 2\n"
+        "18:00 4 client1\n");
+    const club::ColumnarReader reader(data);
+
+    EXPECT_EQ(to_vector(reader.column<std::int32_t>("club.config")), (std::vector{2, 540, 1200, 10}));
+    EXPECT_EQ(to_vector(reader.column<std::int32_t>("event.time")),
+              (std::vector{480, 480, 555, 570, 580, 585, 585, 1080, 1200}));
+    EXPECT_EQ(to_vector(reader.column<std::uint8_t>("event.type")),
+              (std::vector<std::uint8_t>{1, 13, 1, 2, 1, 2, 13, 4, 11}));
+    EXPECT_EQ(to_vector(reader.column<std::int32_t>("event.client")),
+              (std::vector{0, -1, 0, 0, 1, 1, -1, 0, 1}));
+    EXPECT_EQ(to_vector(reader.column<std::int32_t>("event.table")),
+              (std::vector{0, 0, 0, 2, 0, 2, 0, 0, 0}));
+
+    const auto errors = reader.column<std::uint8_t>("event.error");
+    const auto error_names = reader.strings("error.name");
+    EXPECT_EQ(error_names[errors[1]], "NotOpenYet");
+    EXPECT_EQ(error_names[errors[6]], "PlaceIsBusy");
+    EXPECT_EQ(errors[0], 0);
+
+    EXPECT_EQ(reader.strings("client.name"), (std::vector<std::string_view>{"client1", "client2"}));
+    EXPECT_EQ(to_vector(reader.column<std::int64_t>("table.revenue")), (std::vector<std::int64_t>{0, 90}));
+    EXPECT_EQ(to_vector(reader.column<std::int32_t>("table.occupancy")), (std::vector{0, 510}));
+    EXPECT_EQ(to_vector(reader.column<std::int32_t>("input.error_line")), (std::vector{0}));
+    EXPECT_TRUE(reader.column<char>("input.error_text").empty());
+}
+
+TEST(ColumnarTest, CorruptedInputKeepsOffendingLine) {
+    const std::string data = run_columnar(
+        "1\n"
+        "09:00 20:00\n"
+        "10\n"
+        "09:15 1 Client1\n");
+    const club::ColumnarReader reader(data);
+
+    EXPECT_TRUE(reader.column<std::int32_t>("club.config").empty());
+    EXPECT_TRUE(reader.column<std::int32_t>("event.time").empty());
+    EXPECT_EQ(to_vector(reader.column<std::int32_t>("input.error_line")), (std::vector{4}));
+    const auto text = reader.column<char>("input.error_text");
+    EXPECT_EQ(std::string(text.begin(), text.end()), "09:15 1 Client1");
+}
+
+TEST(ColumnarTest, ReaderRejectsForeignData) {
+    const std::string text = "09:00\n20:00\n1 0 00:00\n";
+    EXPECT_THROW(club::ColumnarReader{text}, std::runtime_error);
+
+    std::string data = run_columnar("1\n09:00 20:00\n10\n");
+    const club::ColumnarReader reader(data);
+    EXPECT_FALSE(reader.has("no.such.column"));
+    EXPECT_THROW((void) reader.column<std::int64_t>("event.time"), std::runtime_error);
+
+    data.resize(data.size() / 2);
+    EXPECT_THROW(club::ColumnarReader{data}, std::runtime_error);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "Club/Club.h"
+#include "Club/Compression.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::string compress(const std::string &data, const club::Compression compression) {
+        std::ostringstream sink;
+        club::CompressingStream compressed(sink, compression);
+        compressed << data;
+        compressed.finish();
+        return sink.str();
+    }
+
+    std::string decompress(const std::string &data, const club::Compression compression) {
+        std::istringstream source(data);
+        club::DecompressingStream decompressed(source, compression);
+        return {std::istreambuf_iterator<char>(decompressed), {}};
+    }
+
+    // Hands out the data a few bytes at a time and can't seek, like a pipe
+    class PipeBuffer : public std::streambuf {
+        std::string data;
+        std::size_t pos = 0;
+        char chunk[3];
+
+    public:
+        explicit PipeBuffer(std::string data) : data(std::move(data)) {
+        }
+
+    protected:
+        int_type underflow() override {
+            if (pos == data.size()) {
+                return traits_type::eof();
+            }
+            const std::size_t size = data.copy(chunk, sizeof(chunk), pos);
+            pos += size;
+            setg(chunk, chunk, chunk + size);
+            return traits_type::to_int_type(*gptr());
+        }
+    };
+
+    std::string run_club(std::istream &conf) {
+        std::ostringstream out;
+        club::Club club(conf, out);
+        club.run();
+        return out.str();
+    }
+}
+
+class CompressionTest : public ::testing::TestWithParam<club::Compression> {
+protected:
+    void SetUp() override {
+        if (!club::is_supported(GetParam())) {
+            GTEST_SKIP() << "compression format is not built in";
+        }
+    }
+};
+
+TEST_P(CompressionTest, RoundTripAcrossBlocks) {
+    std::string data;
+    for (int i = 0; data.size() < 3 << 20; i++) {
+        data += "09:" + std::to_string(i % 60) + " 1 client" + std::to_string(i) + "\n";
+    }
+    const std::string compressed = compress(data, GetParam());
+    EXPECT_LT(compressed.size(), data.size() / 4);
+
+    EXPECT_EQ(club::detect_compression(compressed), GetParam());
+    EXPECT_EQ(decompress(compressed, GetParam()), data);
+}
+
+TEST_P(CompressionTest, ConcatenatedStreams) {
+    EXPECT_EQ(decompress(compress("first\n", GetParam()) + compress("second\n", GetParam()), GetParam()),
+              "first\nsecond\n");
+}
+
+TEST_P(CompressionTest, TruncatedInputThrows) {
+    const std::string compressed = compress(std::string(100000, 'x'), GetParam());
+    EXPECT_THROW(decompress(compressed.substr(0, compressed.size() / 2), GetParam()), std::runtime_error);
+}
+
+// A compressed log gives exactly the same result, including the echo of a bad line
+TEST_P(CompressionTest, ClubReadsCompressedLogs) {
+    const fs::path data_dir = fs::current_path() / "tests" / "data";
+    ASSERT_TRUE(fs::exists(data_dir));
+    for (const auto &entry: fs::recursive_directory_iterator(data_dir)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".in" || fs::file_size(entry.path()) == 0) {
+            continue;
+        }
+        std::ifstream file(entry.path(), std::ios::binary);
+        const std::string input{std::istreambuf_iterator<char>(file), {}};
+
+        std::istringstream plain(input);
+        std::istringstream compressed(compress(input, GetParam()));
+        EXPECT_EQ(run_club(compressed), run_club(plain)) << entry.path();
+    }
+}
+
+TEST_P(CompressionTest, DetectedWithoutSeeking) {
+    const fs::path input = fs::current_path() / "tests" / "data" / "legacy" / "test1.in";
+    ASSERT_TRUE(fs::exists(input));
+    std::ifstream file(input, std::ios::binary);
+    const std::string log{std::istreambuf_iterator<char>(file), {}};
+
+    PipeBuffer pipe(compress(log, GetParam()));
+    std::istream piped(&pipe);
+    ASSERT_EQ(piped.rdbuf()->pubseekoff(0, std::ios::cur, std::ios::in), std::streampos(-1));
+    std::istringstream plain(log);
+    EXPECT_EQ(run_club(piped), run_club(plain));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Formats,
+    CompressionTest,
+    ::testing::Values(club::Compression::Gzip, club::Compression::Zstd),
+    [](const ::testing::TestParamInfo<club::Compression> &info) {
+        return info.param == club::Compression::Gzip ? "Gzip" : "Zstd";
+    }
+);
+
+TEST(CompressionDetectTest, PlainTextIsPassedThrough) {
+    const std::string text = "(1\n09:00 20:00\n10\n";
+    EXPECT_EQ(club::detect_compression(text), club::Compression::None);
+    EXPECT_EQ(club::detect_compression("\x1f"), club::Compression::None);
+
+    PipeBuffer pipe(text);
+    std::istream source(&pipe);
+    club::DecompressingStream plain(source);
+    EXPECT_EQ(plain.compression(), club::Compression::None);
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(plain), {}), text);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Club/Club.h"
+#include "Club/Columnar.h"
+
+namespace {
+    const std::string day =
+            "3\n"
+            "09:00 20:00\n"
+            "10\n"
+            "09:00 1 alice\n"
+            "09:00 2 alice 1\n"
+            "09:05 1 bob\n"
+            "09:05 2 bob 2\n"
+            "09:10 1 carol\n"
+            "09:10 2 carol 3\n"
+            "09:20 1 dave\n"
+            "09:20 3 dave\n"
+            "10:00 4 bob\n"
+            "11:00 4 carol\n"
+            "11:30 2 alice 3\n"
+            "13:00 4 alice\n"
+            "13:10 1 bob\n"
+            "13:10 2 bob 1\n"
+            "13:20 1 erin\n";
+
+    std::string run(const bool keeps_ledger, const club::OutputFormat format = club::OutputFormat::Text,
+                    const std::string &input = day) {
+        std::istringstream conf(input);
+        std::ostringstream out;
+        club::Club club(conf, out);
+        if (keeps_ledger) {
+            club.enable_ledger();
+        }
+        club.run(format);
+        return out.str();
+    }
+}
+
+TEST(LedgerTest, FollowsPerTableSummary) {
+    const std::string plain = run(false);
+    const std::string with_ledger = run(true);
+
+    ASSERT_TRUE(with_ledger.starts_with(plain));
+    EXPECT_TRUE(plain.ends_with("1 100 09:20\n2 110 10:55\n3 40 03:20\n"));
+    // alice moves from table 1 to 3: 2.5 and 1.5 hours are rounded up separately
+    EXPECT_EQ(with_ledger.substr(plain.size()),
+              "alice 2 5 50 1,3\n"
+              "bob 2 8 80 1,2\n"
+              "carol 1 2 20 3\n"
+              "dave 1 10 100 2\n");
+}
+
+TEST(LedgerTest, ZeroMinuteSitIsNotBilled) {
+    const std::string input =
+            "2\n"
+            "09:00 20:00\n"
+            "10\n"
+            "09:00 1 a\n"
+            "09:10 2 a 1\n"
+            "09:10 2 a 2\n"
+            "10:00 4 a\n"
+            "10:00 1 b\n"
+            "10:00 2 b 1\n"
+            "10:00 4 b\n";
+    const std::string plain = run(false, club::OutputFormat::Text, input);
+    const std::string with_ledger = run(true, club::OutputFormat::Text, input);
+
+    ASSERT_TRUE(with_ledger.starts_with(plain));
+    EXPECT_TRUE(plain.ends_with("1 0 00:00\n2 10 00:50\n"));
+    EXPECT_EQ(with_ledger.substr(plain.size()), "a 1 1 10 2\n");
+}
+
+TEST(LedgerTest, ColumnsMatchTableRevenue) {
+    const std::string data = run(true, club::OutputFormat::Columnar);
+    const club::ColumnarReader reader(data);
+
+    const auto names = reader.strings("client.name");
+    const auto clients = reader.column<std::int32_t>("ledger.client");
+    const auto amount = reader.column<std::int64_t>("ledger.amount");
+    const auto offsets = reader.column<std::uint32_t>("ledger.table_offsets");
+    const auto tables = reader.column<std::int32_t>("ledger.tables");
+    ASSERT_EQ(clients.size(), 4u);
+    ASSERT_EQ(offsets.size(), 5u);
+
+    const auto revenue = reader.column<std::int64_t>("table.revenue");
+    EXPECT_EQ(std::accumulate(amount.begin(), amount.end(), std::int64_t{0}),
+              std::accumulate(revenue.begin(), revenue.end(), std::int64_t{0}));
+
+    for (std::size_t i = 0; i < clients.size(); i++) {
+        if (names[clients[i]] == "alice") {
+            EXPECT_EQ(reader.column<std::int32_t>("ledger.sessions")[i], 2);
+            EXPECT_EQ(reader.column<std::int32_t>("ledger.hours")[i], 5);
+            EXPECT_EQ(amount[i], 50);
+            EXPECT_EQ(std::vector<std::int32_t>(tables.begin() + offsets[i], tables.begin() + offsets[i + 1]),
+                      (std::vector<std::int32_t>{1, 3}));
+        }
+    }
+}
+
+TEST(LedgerTest, DisabledByDefault) {
+    const std::string data = run(false, club::OutputFormat::Columnar);
+    const club::ColumnarReader reader(data);
+    EXPECT_FALSE(reader.has("ledger.client"));
+}
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Club/Club.h"
+#include "Club/EventRouter.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::vector<std::string> read_lines(const fs::path &path) {
+        std::ifstream file(path);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // Splits the router output back into per-venue results
+    std::map<std::string, std::vector<std::string> > group_by_venue(const std::string &output) {
+        std::map<std::string, std::vector<std::string> > results;
+        std::istringstream lines(output);
+        std::string line;
+        while (std::getline(lines, line)) {
+            const std::size_t space = line.find(' ');
+            results[line.substr(0, space)].push_back(line.substr(space + 1));
+        }
+        return results;
+    }
+}
+
+// Every end-to-end case is replayed as a separate venue, with all venues interleaved
+// line by line, and must produce exactly the same result as the standalone run.
+TEST(EventRouterTest, InterleavedVenuesMatchStandaloneRuns) {
+    const fs::path data_dir = fs::current_path() / "tests" / "data";
+    ASSERT_TRUE(fs::exists(data_dir));
+
+    std::map<std::string, std::vector<std::string> > inputs;
+    std::map<std::string, std::vector<std::string> > expected;
+    for (const auto &entry: fs::recursive_directory_iterator(data_dir)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".in") {
+            continue;
+        }
+        std::string venue = fs::relative(entry.path(), data_dir).replace_extension("").generic_string();
+        std::replace(venue.begin(), venue.end(), '/', '_');
+        inputs[venue] = read_lines(entry.path());
+        expected[venue] = read_lines(fs::path(entry.path()).replace_extension(".out"));
+    }
+
+    std::ostringstream out;
+    {
+        club::EventRouter router(4, out);
+        for (std::size_t i = 0; !inputs.empty(); i++) {
+            bool has_more = false;
+            for (const auto &[venue, lines]: inputs) {
+                if (i < lines.size()) {
+                    router.route(venue + " " + lines[i]);
+                    has_more = true;
+                }
+            }
+            if (!has_more) {
+                break;
+            }
+        }
+        for (const auto &[venue, lines]: inputs) {
+            router.route("CLOSE " + venue);
+        }
+    }
+
+    const auto results = group_by_venue(out.str());
+    for (const auto &[venue, lines]: expected) {
+        const auto it = results.find(venue);
+        ASSERT_NE(it, results.end()) << venue;
+        EXPECT_EQ(it->second, lines) << venue;
+    }
+}
+
+TEST(EventRouterTest, ResultOnDemandKeepsVenueOpen) {
+    std::ostringstream out;
+    {
+        club::EventRouter router(2, out);
+        router.route("a 1");
+        router.route("a 09:00 19:00");
+        router.route("a 10");
+        router.route("a 09:00 1 client1");
+        router.route("a 09:00 2 client1 1");
+        router.route("RESULT a");
+        router.route("a 11:00 4 client1");
+        router.route("CLOSE a");
+        router.route("RESULT a");
+    }
+    const std::vector<std::string> expected = {
+        "09:00", "09:00 1 client1", "09:00 2 client1 1", "19:00", "1 0 00:00",
+        "09:00", "09:00 1 client1", "09:00 2 client1 1", "11:00 4 client1", "19:00", "1 20 02:00",
+        "",
+    };
+    EXPECT_EQ(group_by_venue(out.str())["a"], expected);
+}
+
+TEST(EventRouterTest, CommandWithoutVenueIsRejected) {
+    std::ostringstream out;
+    std::ostringstream err;
+    {
+        club::EventRouter router(2, out);
+        std::istringstream in("a 1\n"
+            "a 09:00 19:00\n"
+            "RESULT\n"
+            "a 10\n"
+            "CLOSE\n"
+            "CLOSE \n"
+            "CLOSE a\n");
+        router.serve(in, err);
+        EXPECT_FALSE(router.route("RESULT"));
+    }
+    EXPECT_EQ(err.str(),
+              "Line 3 names no venue, skipped: RESULT\n"
+              "Line 5 names no venue, skipped: CLOSE\n"
+              "Line 6 names no venue, skipped: CLOSE \n");
+    const auto results = group_by_venue(out.str());
+    EXPECT_EQ(results.size(), 1u);
+    EXPECT_EQ(results.at("a"), (std::vector<std::string>{"09:00", "19:00", "1 0 00:00"}));
+}
+
+TEST(EventRouterTest, FailingVenueDoesNotStopOthers) {
+    std::ostringstream out;
+    {
+        club::EventRouter router(2, out);
+        for (const std::string venue: {"a", "b", "c"}) {
+            // the table count of b can't be allocated
+            router.route(venue + (venue == "b" ? " 2000000000" : " 1"));
+            router.route(venue + " 09:00 19:00");
+            router.route(venue + " 10");
+        }
+        for (const std::string venue: {"a", "b", "c"}) {
+            router.route(venue + " 09:00 1 client1");
+            router.route(venue + " 09:00 2 client1 1");
+            router.route("CLOSE " + venue);
+        }
+    }
+    const auto results = group_by_venue(out.str());
+    const std::vector<std::string> expected = {
+        "09:00", "09:00 1 client1", "09:00 2 client1 1", "19:00 11 client1", "19:00", "1 100 10:00",
+    };
+    EXPECT_EQ(results.at("a"), expected);
+    EXPECT_EQ(results.at("c"), expected);
+    ASSERT_EQ(results.at("b").size(), 1u);
+    EXPECT_TRUE(results.at("b")[0].starts_with("Error: ")) << results.at("b")[0];
+}
+
+// A stream that is both readable and writable is parsed, live clubs are only made by name
+TEST(EventRouterTest, LiveClubIsNotConfusedWithParsedOne) {
+    static_assert(std::is_constructible_v<club::Club, std::stringstream &>);
+    static_assert(!std::is_constructible_v<club::Club, std::ostringstream &>);
+
+    std::ostringstream out;
+    club::Club club = club::Club::live(out);
+    club.report();
+    EXPECT_EQ(out.str(), "\n");
+}
+
+// Local load generator: many venues with identical days spread over all shards
+TEST(EventRouterTest, ManyVenuesLoad) {
+    constexpr int venues = 500;
+    constexpr int clients = 200;
+    std::ostringstream out;
+    {
+        club::EventRouter router(0, out);
+        for (int v = 0; v < venues; v++) {
+            const std::string tag = "v" + std::to_string(v) + " ";
+            router.route(tag + "5");
+            router.route(tag + "08:00 23:00");
+            router.route(tag + "7");
+        }
+        for (int c = 0; c < clients; c++) {
+            const int minute = 8 * 60 + c * 3;
+            const std::string time = (minute / 60 < 10 ? "0" : "") + std::to_string(minute / 60) + ":"
+                                     + (minute % 60 < 10 ? "0" : "") + std::to_string(minute % 60);
+            for (int v = 0; v < venues; v++) {
+                const std::string tag = "v" + std::to_string(v) + " ";
+                router.route(tag + time + " 1 c" + std::to_string(c));
+                router.route(tag + time + " 2 c" + std::to_string(c) + " " + std::to_string(c % 5 + 1));
+                router.route(tag + time + " 4 c" + std::to_string(c));
+            }
+        }
+        for (int v = 0; v < venues; v++) {
+            router.route("CLOSE v" + std::to_string(v));
+        }
+    }
+    const auto results = group_by_venue(out.str());
+    ASSERT_EQ(results.size(), static_cast<std::size_t>(venues));
+    const auto &reference = results.begin()->second;
+    // opening and closing time, three events per client and five tables
+    EXPECT_EQ(reference.size(), static_cast<std::size_t>(2 + clients * 3 + 5));
+    for (const auto &[venue, lines]: results) {
+        EXPECT_EQ(lines, reference) << venue;
+    }
+}